@@ -0,0 +1,27 @@
+#ifndef DEADLOCK_API_H
+#define DEADLOCK_API_H
+
+#include <pthread.h>
+
+/*
+ * Direct in-process API. These lock/unlock the real pthread mutex and record
+ * it in the tracker without going through the interposed pthread symbols,
+ * so the lock still shows up in deadlock reports.
+ *
+ * Symbols are only available while libdeadlock is loaded (preloaded or
+ * linked), callers that want to work without it should declare them weak.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int deadlock_mutex_lock(pthread_mutex_t *mutex);
+int deadlock_mutex_unlock(pthread_mutex_t *mutex);
+int deadlock_mutex_trylock(pthread_mutex_t *mutex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
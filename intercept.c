@@ -7,10 +7,35 @@
 #include <string.h>
 #include "tracker.h"
 #include "graph.h"
+#include "deadlock.h"
+#include "suppress.h"
+#include "stats.h"
+#include <signal.h>
 #include <execinfo.h>
 #include <stdlib.h>
 #include <stdint.h>
-
+#include <stdatomic.h>
+#include <time.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+#ifdef DEADLOCK_WRAP
+/*
+ * --- Real functions (static build) ---
+ * libdeadlock.a is linked with -Wl,--wrap=pthread_mutex_{lock,unlock,trylock},
+ * the linker points __real_* straight at libc, so no lookup or indirection.
+ */
+int __real_pthread_mutex_lock(pthread_mutex_t *);
+int __real_pthread_mutex_unlock(pthread_mutex_t *);
+int __real_pthread_mutex_trylock(pthread_mutex_t *);
+
+#define real_pthread_mutex_lock __real_pthread_mutex_lock
+#define real_pthread_mutex_unlock __real_pthread_mutex_unlock
+#define real_pthread_mutex_trylock __real_pthread_mutex_trylock
+#else
 /* --- Real function pointers --- */
 typedef int (*real_lock_t)(pthread_mutex_t *);
 typedef int (*real_unlock_t)(pthread_mutex_t *);
@@ -19,18 +44,43 @@ typedef int (*real_trylock_t)(pthread_mutex_t *);
 static real_lock_t real_pthread_mutex_lock = NULL;
 static real_unlock_t real_pthread_mutex_unlock = NULL;
 static real_trylock_t real_pthread_mutex_trylock = NULL;
+#endif
 
 /* --- Global simple tracker --- */
 static simple_tracker_t tracker;
 
+/* --- Suppressed callsites (immutable after deadlock_init) --- */
+static suppress_filter_t suppress;
+
 /* --- Thread-local guards --- */
 static __thread int in_hook = 0;                 // prevents recursion in hooks
 static __thread int in_deadlock_detection = 0;  // prevents start of detection while already being done
+#ifndef DEADLOCK_WRAP
 static __thread int initializing = 0;
+#endif
+
+/*
+ * Mutexes this thread acquired through the tracker. An unlock of anything else
+ * (suppressed acquisitions, locks taken before we were loaded) has nothing to
+ * clear and skips the tracker. Once a thread holds more than MAX_HELD at a
+ * time we stop trusting misses and send every unlock to the tracker.
+ */
+#define MAX_HELD 64
+static __thread pthread_mutex_t *held[MAX_HELD];
+static __thread int held_count = 0;
+static __thread int held_overflow = 0;
 
 /* --- Monitor control --- */
+enum { MONITOR_IDLE = 0, MONITOR_STARTING, MONITOR_RUNNING, MONITOR_FAILED };
+
+static atomic_int monitor_state = MONITOR_IDLE;
+static pthread_t monitor_tid;
+static pthread_mutex_t monitor_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t monitor_cv;
 static volatile int monitor_running = 1;
 static int deadlock_reported = 0;
+static int dump_on_exit = 0;
+static int avoid_mode = 0;      // fail contended locks with EDEADLK instead of blocking into a cycle
 
 // we had to use this to avoid warnings
 static inline void safe_write(int fd, const void *buf, size_t n) {
@@ -38,6 +88,54 @@ static inline void safe_write(int fd, const void *buf, size_t n) {
     (void)_r; 
 }
 
+/*
+ * Run "addr2line -f -p -e bin where" and read its first line into out.
+ * Spawned directly (no sh) with LD_PRELOAD stripped from its environment,
+ * so neither the shell nor addr2line load this library again.
+ */
+static int run_addr2line(const char *bin, const char *where, char *out, size_t cap) {
+    size_t n = 0;
+    while (environ[n]) n++;
+    char **envp = malloc(sizeof(char *) * (n + 2));
+    if (!envp) return 0;
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (strncmp(environ[i], "LD_PRELOAD=", 11) != 0) envp[k++] = environ[i];
+    }
+    envp[k++] = "DEADLOCK_QUIET=1";
+    envp[k] = NULL;
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        free(envp);
+        return 0;
+    }
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_adddup2(&fa, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&fa, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addclose(&fa, fds[0]);
+    posix_spawn_file_actions_addclose(&fa, fds[1]);
+
+    char *argv[] = { "addr2line", "-f", "-p", "-e", (char *)bin, (char *)where, NULL };
+    pid_t pid;
+    int rc = posix_spawnp(&pid, "addr2line", &fa, NULL, argv, envp);
+    posix_spawn_file_actions_destroy(&fa);
+    free(envp);
+    close(fds[1]);
+
+    size_t len = 0;
+    if (rc == 0) {
+        ssize_t r;
+        while (len + 1 < cap && (r = read(fds[0], out + len, cap - 1 - len)) > 0) len += (size_t)r;
+        waitpid(pid, NULL, 0);
+    }
+    close(fds[0]);
+    out[len] = '\0';
+    return len > 0;
+}
+
 // we use this helper to resolve stack line with addr2line
 void print_resolved_frame(void *addr) {
     // subtract 1 from the address to get the call site instead of return address
@@ -52,30 +150,40 @@ void print_resolved_frame(void *addr) {
     char *off_start = strchr(buf, '(');
     char *off_end = off_start ? strchr(off_start, ')') : NULL;
 
+#ifdef DEADLOCK_WRAP
+    // static binaries have no dynamic symbol table, so backtrace_symbols only
+    // gives "[addr]", let addr2line look the absolute address up in our own image
+    if (!off_start || !off_end) {
+        char exe[512];
+        ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+        if (len > 0) {
+            exe[len] = '\0';
+            char line[600];
+            snprintf(line, sizeof(line), "%s(%p)", exe, call_site);
+            free(buf);
+            buf = strdup(line);
+            bin_name = buf;
+            off_start = strchr(buf, '(');
+            off_end = strchr(off_start, ')');
+        }
+    }
+#endif
+
     if (off_start && off_end) {
         *off_start = '\0'; 
         off_start++;       
         *off_end = '\0';   
 
-        char cmd[1024];
-        snprintf(cmd, sizeof(cmd), 
-                 "LD_PRELOAD= DEADLOCK_QUIET=1 addr2line -f -p -e %s %s 2>/dev/null", 
-                 bin_name, off_start);
-
-        FILE *fp = popen(cmd, "r");
-        if (fp) {
-            char line[512];
-            if (fgets(line, sizeof(line), fp) && line[0] != '?') {
-                line[strcspn(line, "\n")] = 0;
-                safe_write(2, "      -> ", 9);
-                safe_write(2, line, strlen(line));
-                safe_write(2, "\n", 1);
-            } else {
-                safe_write(2, "      (raw): ", 13);
-                safe_write(2, symbols[0], strlen(symbols[0]));
-                safe_write(2, "\n", 1);
-            }
-            pclose(fp);
+        char line[512];
+        if (run_addr2line(bin_name, off_start, line, sizeof(line)) && line[0] != '?') {
+            line[strcspn(line, "\n")] = 0;
+            safe_write(2, "      -> ", 9);
+            safe_write(2, line, strlen(line));
+            safe_write(2, "\n", 1);
+        } else {
+            safe_write(2, "      (raw): ", 13);
+            safe_write(2, symbols[0], strlen(symbols[0]));
+            safe_write(2, "\n", 1);
         }
     } else {
         safe_write(2, "      (raw): ", 13);
@@ -86,15 +194,48 @@ void print_resolved_frame(void *addr) {
     free(symbols);
 }
 
+// record cost and size of one monitor scan
+static void record_scan(const wait_for_graph_t *graph, uint64_t start) {
+    uint64_t elapsed = stats_now_ns() - start;
+    size_t edges = 0;
+    for (size_t i = 0; i < graph->node_count; ++i) edges += graph->nodes[i].count;
+
+    stats_add(STAT_SCANS, 1);
+    stats_add(STAT_SCAN_NS, elapsed);
+    stats_max(STAT_SCAN_NS_MAX, elapsed);
+    stats_max(STAT_GRAPH_NODES_MAX, graph->node_count);
+    stats_max(STAT_GRAPH_EDGES_MAX, edges);
+}
+
+static void stats_signal_handler(int sig) {
+    (void)sig;
+    stats_print(STDERR_FILENO);
+}
+
 // we monitor with this function
 static void *monitor_func(void *arg) {
     (void)arg; // again avoids warnings
 
     in_hook = 1;
 
-    while (monitor_running) {
-        // sleep 100ms between checks ( can be customizied )
-        usleep(100 * 1000);
+    for (;;) {
+        // sleep 100ms between checks ( can be customizied ), deadlock_fini wakes us early
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += 100 * 1000 * 1000;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&monitor_mtx);
+        while (monitor_running &&
+               pthread_cond_timedwait(&monitor_cv, &monitor_mtx, &deadline) != ETIMEDOUT) {
+            // spurious wakeup, keep waiting until the deadline
+        }
+        int running = monitor_running;
+        pthread_mutex_unlock(&monitor_mtx);
+        if (!running) break;
 
         if (deadlock_reported) continue;
 
@@ -103,13 +244,17 @@ static void *monitor_func(void *arg) {
         in_deadlock_detection = 1;
 
         // build snapshot of tracker 
+        uint64_t scan_start = stats_clock();
         wait_for_graph_t graph;
         tracker_build_wait_for_graph(&tracker, &graph);
 
         // detect deadlock and extract cycle
         pthread_t cycle[MAX_THREADS];
         size_t cycle_len = 0;
-        if (detect_deadlock_cycle(&graph, cycle, &cycle_len)) {
+        int found = detect_deadlock_cycle(&graph, cycle, &cycle_len);
+        if (stats_enabled) record_scan(&graph, scan_start);
+
+        if (found) {
             deadlock_reported = 1;
             safe_write(2, "!!! Deadlock detected !!!\n\nCycle: ", 34);
 
@@ -127,7 +272,7 @@ static void *monitor_func(void *arg) {
             // safe stack printing (Release lock before I/O)
             safe_write(STDERR_FILENO, "\nWait-for Locations:\n\n", 23);
             for (size_t i = 0; i < cycle_len; ++i) {
-                void *temp_stack[10];
+                void *temp_stack[MAX_STACK_DEPTH];
                 int frames = 0;
                 pthread_t tid = cycle[i];
 
@@ -167,7 +312,47 @@ static void *monitor_func(void *arg) {
     return NULL;
 }
 
-// Constructor: initialize tracker, resolve functions, and start monitor
+/*
+ * Spawn the monitor the first time a thread has to block on a tracked mutex.
+ * Processes that never contend (most short-lived tools) never pay for it.
+ */
+static void start_monitor(void) {
+    int expected = MONITOR_IDLE;
+    if (atomic_load_explicit(&monitor_state, memory_order_acquire) != MONITOR_IDLE) return;
+    if (!atomic_compare_exchange_strong(&monitor_state, &expected, MONITOR_STARTING)) return;
+
+    if (pthread_create(&monitor_tid, NULL, monitor_func, NULL) != 0) {
+        safe_write(2, "WARNING: couldn't create monitor thread\n", 40);
+        atomic_store(&monitor_state, MONITOR_FAILED);
+        return;
+    }
+    atomic_store(&monitor_state, MONITOR_RUNNING);
+}
+
+// monitor sleeps on a monotonic clock so wall clock jumps don't stall it
+static void monitor_sync_init(void) {
+    pthread_mutex_t fresh = PTHREAD_MUTEX_INITIALIZER;
+    monitor_mtx = fresh;
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&monitor_cv, &cattr);
+    pthread_condattr_destroy(&cattr);
+}
+
+/*
+ * The monitor doesn't survive fork, let the child start its own. The parent's
+ * monitor may have held monitor_mtx (or been waiting on monitor_cv) at the
+ * time of the fork, so both are rebuilt from scratch.
+ */
+static void monitor_atfork_child(void) {
+    monitor_sync_init();
+    atomic_store(&monitor_state, MONITOR_IDLE);
+    monitor_running = 1;
+}
+
+// Constructor: initialize tracker and resolve functions, monitor is started lazily
 __attribute__((constructor))
 static void deadlock_init(void) {
     if (in_hook) return;
@@ -179,6 +364,47 @@ static void deadlock_init(void) {
     
     tracker_init(&tracker);
 
+    // DEADLOCK_UNWIND=fp switches to the frame-pointer walker
+    const char *unwind = getenv("DEADLOCK_UNWIND");
+    if (unwind && strcmp(unwind, "fp") == 0) {
+        tracker.unwind = UNWIND_FRAME_POINTER;
+    }
+
+    // DEADLOCK_SUPPRESS=file lists functions/callsites whose acquisitions are never tracked
+    const char *suppress_path = getenv("DEADLOCK_SUPPRESS");
+    if (suppress_path && suppress_load(&suppress, suppress_path) < 0) {
+        safe_write(2, "WARNING: couldn't read suppression file\n", 40);
+    }
+
+    // DEADLOCK_AVOID=1 makes pthread_mutex_lock return EDEADLK instead of closing a cycle
+    const char *avoid = getenv("DEADLOCK_AVOID");
+    avoid_mode = avoid && avoid[0] == '1';
+
+    // DEADLOCK_STATS=1 turns on the self-profiling counters, printed at exit
+    const char *stats = getenv("DEADLOCK_STATS");
+    if (stats && stats[0] == '1') stats_init();
+
+    // DEADLOCK_STATS_SIGNAL=<signum> also prints them on that signal, replacing the app's handler
+    const char *stats_sig = getenv("DEADLOCK_STATS_SIGNAL");
+    int sig = stats_sig ? atoi(stats_sig) : 0;
+    if (stats_enabled && sig > 0 && sig < NSIG && sig != SIGKILL && sig != SIGSTOP) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = stats_signal_handler;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(sig, &sa, NULL);
+    }
+
+    const char *depth = getenv("DEADLOCK_STACK_DEPTH");
+    if (depth) {
+        int d = atoi(depth);
+        if (d < 1) d = 1;
+        if (d > MAX_STACK_DEPTH) d = MAX_STACK_DEPTH;
+        tracker.stack_depth = d;
+    }
+
+#ifndef DEADLOCK_WRAP
     real_pthread_mutex_lock =
         (real_lock_t)dlsym(RTLD_NEXT, "pthread_mutex_lock");
     real_pthread_mutex_unlock =
@@ -189,57 +415,163 @@ static void deadlock_init(void) {
     if (!real_pthread_mutex_lock || !real_pthread_mutex_unlock || !real_pthread_mutex_trylock) {
         safe_write(2, "ERROR: dlsym failed\n", 20);
     }
+#endif
 
-    // create detached monitor thread
-    pthread_t mid;
-    pthread_attr_t attr;
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
-    if (pthread_create(&mid, &attr, monitor_func, NULL) != 0) {
-        safe_write(2, "WARNING: couldn't create monitor thread\n", 39);
-    }
-    pthread_attr_destroy(&attr);
+    // DEADLOCK_DUMP_ON_EXIT=1 prints the final tracker state from the destructor
+    const char *dump = getenv("DEADLOCK_DUMP_ON_EXIT");
+    dump_on_exit = dump && dump[0] == '1';
+
+    monitor_sync_init();
+    pthread_atfork(NULL, NULL, monitor_atfork_child);
 
     in_hook = 0;
 }
 
-// Destructor: stop monitor and print final tracker state
+// Destructor: wake and join the monitor (if it was ever started), optionally dump state
 __attribute__((destructor))
 static void deadlock_fini(void) {
-    monitor_running = 0;
-    // give monitor a moment to exit if it was sleeping
-    usleep(200 * 1000);
-    tracker_print_state(&tracker);
+    in_hook = 1;
+
+    if (atomic_load(&monitor_state) == MONITOR_RUNNING) {
+        pthread_mutex_lock(&monitor_mtx);
+        monitor_running = 0;
+        pthread_cond_signal(&monitor_cv);
+        pthread_mutex_unlock(&monitor_mtx);
+        pthread_join(monitor_tid, NULL);
+    }
+
+    if (dump_on_exit) tracker_print_state(&tracker);
+    if (stats_enabled) stats_print(STDERR_FILENO);
     tracker_destroy(&tracker);
 }
 
+/* --- Tracked operations (shared by the hooks and the direct API) --- */
+
+// log the cycle a lock would have closed in avoidance mode
+static void report_avoided(pthread_mutex_t *mutex, pthread_t *chain, size_t chain_len) {
+    char buf[256];
+    int n = snprintf(buf, sizeof(buf), "!!! Deadlock avoided !!! mutex %p -> EDEADLK\n\nWould-be cycle: ",
+                     (void *)mutex);
+    safe_write(2, buf, n);
+    for (size_t i = 0; i < chain_len; ++i) {
+        n = snprintf(buf, sizeof(buf), "  T%lu -> ", (unsigned long)chain[i]);
+        safe_write(2, buf, n);
+    }
+    n = snprintf(buf, sizeof(buf), "  T%lu\n", (unsigned long)chain[0]);
+    safe_write(2, buf, n);
+}
+
+/*
+ * Acquisitions whose caller lies in a suppressed range go straight to the real
+ * function and are never recorded, so the held set below also lets their
+ * unlocks bypass the tracker, whatever the unlock's callsite.
+ */
+#define IS_SUPPRESSED(caller) \
+    (suppress.count && suppress_match(&suppress, (uintptr_t)(caller)))
+
+static void held_push(pthread_mutex_t *mutex) {
+    if (held_count < MAX_HELD) held[held_count++] = mutex;
+    else held_overflow = 1;
+}
+
+// returns 1 if the unlock has to go through the tracker
+static int held_pop(pthread_mutex_t *mutex) {
+    for (int i = held_count - 1; i >= 0; --i) {
+        if (held[i] == mutex) {
+            held[i] = held[--held_count];
+            return 1;
+        }
+    }
+    return held_overflow;
+}
+
+static int tracked_lock(pthread_mutex_t *mutex, void *caller) {
+    uint64_t start = stats_clock();
+    STATS_ADD(STAT_HOOK_CALLS, 1);
+
+    // uncontended acquisitions never block, so they skip stack capture and the monitor
+    int rc = real_pthread_mutex_trylock(mutex);
+    if (rc == EBUSY) {
+        start_monitor();
+        if (avoid_mode) {
+            pthread_t chain[AVOID_MAX_CHAIN];
+            size_t chain_len = 0;
+            if (tracker_waiting_checked(&tracker, pthread_self(), mutex, caller, chain, &chain_len)) {
+                report_avoided(mutex, chain, chain_len);
+                stats_elapsed(STAT_HOOK_NS, start);
+                return EDEADLK;
+            }
+        } else {
+            tracker_waiting(&tracker, pthread_self(), mutex, caller);
+        }
+
+        // time spent blocked in the real lock isn't our overhead
+        stats_elapsed(STAT_HOOK_NS, start);
+        rc = real_pthread_mutex_lock(mutex);
+        start = stats_clock();
+
+        if (rc != 0) {
+            tracker_waiting(&tracker, pthread_self(), NULL, NULL);
+        }
+    }
+    if (rc == 0) {
+        tracker_lock_acquired(&tracker, pthread_self(), mutex);
+        held_push(mutex);
+    }
+    stats_elapsed(STAT_HOOK_NS, start);
+    return rc;
+}
+
+static int tracked_unlock(pthread_mutex_t *mutex) {
+    uint64_t start = stats_clock();
+    STATS_ADD(STAT_HOOK_CALLS, 1);
+
+    int rc = real_pthread_mutex_unlock(mutex);
+    if (rc == 0) {
+        tracker_lock_released(&tracker, pthread_self(), mutex);
+    }
+    stats_elapsed(STAT_HOOK_NS, start);
+    return rc;
+}
+
+static int tracked_trylock(pthread_mutex_t *mutex) {
+    uint64_t start = stats_clock();
+    STATS_ADD(STAT_HOOK_CALLS, 1);
+
+    int rc = real_pthread_mutex_trylock(mutex);
+    if (rc == 0) {
+        tracker_lock_acquired(&tracker, pthread_self(), mutex);
+        held_push(mutex);
+    }
+    stats_elapsed(STAT_HOOK_NS, start);
+    return rc;
+}
+
+#ifndef DEADLOCK_WRAP
+
 /* --- Lock interception --- */
 
 int pthread_mutex_lock(pthread_mutex_t *mutex) {
-    // lazy initialization if pointer is missing
-    if (!real_pthread_mutex_lock) {
+    // lazy initialization if pointer is missing (the fast path below needs trylock too)
+    if (!real_pthread_mutex_lock || !real_pthread_mutex_trylock) {
         if (initializing) return 0;
         initializing = 1;
         real_lock_t temp = (real_lock_t)dlsym(RTLD_NEXT, "pthread_mutex_lock");
-        if (!temp) {
+        real_trylock_t temp_try = (real_trylock_t)dlsym(RTLD_NEXT, "pthread_mutex_trylock");
+        if (!temp || !temp_try) {
             initializing = 0;
             return 0; 
         }
         real_pthread_mutex_lock = temp;
+        real_pthread_mutex_trylock = temp_try;
         initializing = 0;
     }
 
-    if (in_hook) return real_pthread_mutex_lock(mutex);
+    void *caller = __builtin_return_address(0);
+    if (in_hook || IS_SUPPRESSED(caller)) return real_pthread_mutex_lock(mutex);
     in_hook = 1;
 
-    tracker_waiting(&tracker, pthread_self(), mutex);
-
-    int rc = real_pthread_mutex_lock(mutex);
-    if (rc == 0) {
-        tracker_lock_acquired(&tracker, pthread_self(), mutex);
-    } else {
-        tracker_waiting(&tracker, pthread_self(), NULL);
-    }
+    int rc = tracked_lock(mutex, caller);
  
     in_hook = 0;
     return rc;
@@ -264,13 +596,10 @@ int pthread_mutex_unlock(pthread_mutex_t *mutex) {
         initializing = 0;
     }
 
-    if (in_hook) return real_pthread_mutex_unlock(mutex);
+    if (in_hook || !held_pop(mutex)) return real_pthread_mutex_unlock(mutex);
     in_hook = 1;
 
-    int rc = real_pthread_mutex_unlock(mutex);
-    if (rc == 0) {
-        tracker_lock_released(&tracker, pthread_self(), mutex);
-    }
+    int rc = tracked_unlock(mutex);
 
     in_hook = 0;
     return rc;
@@ -296,14 +625,10 @@ int pthread_mutex_trylock(pthread_mutex_t *mutex) {
         initializing = 0;
     }
 
-    if (in_hook) return real_pthread_mutex_trylock(mutex);
+    if (in_hook || IS_SUPPRESSED(__builtin_return_address(0))) return real_pthread_mutex_trylock(mutex);
     in_hook = 1;
 
-    int rc = real_pthread_mutex_trylock(mutex);
-
-    if (rc == 0) {
-        tracker_lock_acquired(&tracker, pthread_self(), mutex);
-    }
+    int rc = tracked_trylock(mutex);
 
     in_hook = 0;
     return rc;
@@ -311,4 +636,42 @@ int pthread_mutex_trylock(pthread_mutex_t *mutex) {
 
 int __pthread_mutex_trylock(pthread_mutex_t *mutex) {
     return pthread_mutex_trylock(mutex);
-}
\ No newline at end of file
+}
+
+#endif /* !DEADLOCK_WRAP */
+
+/* --- Direct in-process API (deadlock.h) --- */
+
+// the constructor has already resolved the real functions, so no lazy paths here
+
+int deadlock_mutex_lock(pthread_mutex_t *mutex) {
+    void *caller = __builtin_return_address(0);
+    if (in_hook || IS_SUPPRESSED(caller)) return real_pthread_mutex_lock(mutex);
+    in_hook = 1;
+    int rc = tracked_lock(mutex, caller);
+    in_hook = 0;
+    return rc;
+}
+
+int deadlock_mutex_unlock(pthread_mutex_t *mutex) {
+    if (in_hook || !held_pop(mutex)) return real_pthread_mutex_unlock(mutex);
+    in_hook = 1;
+    int rc = tracked_unlock(mutex);
+    in_hook = 0;
+    return rc;
+}
+
+int deadlock_mutex_trylock(pthread_mutex_t *mutex) {
+    if (in_hook || IS_SUPPRESSED(__builtin_return_address(0))) return real_pthread_mutex_trylock(mutex);
+    in_hook = 1;
+    int rc = tracked_trylock(mutex);
+    in_hook = 0;
+    return rc;
+}
+
+#ifdef DEADLOCK_WRAP
+/* --- Wrapped symbols (static build), same bodies as the direct API --- */
+int __wrap_pthread_mutex_lock(pthread_mutex_t *mutex) __attribute__((alias("deadlock_mutex_lock")));
+int __wrap_pthread_mutex_unlock(pthread_mutex_t *mutex) __attribute__((alias("deadlock_mutex_unlock")));
+int __wrap_pthread_mutex_trylock(pthread_mutex_t *mutex) __attribute__((alias("deadlock_mutex_trylock")));
+#endif
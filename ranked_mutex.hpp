@@ -0,0 +1,224 @@
+#ifndef DEADLOCK_RANKED_MUTEX_HPP
+#define DEADLOCK_RANKED_MUTEX_HPP
+
+/*
+ * Lock hierarchy types for C++ (header-only, C++17).
+ *
+ * Every ranked_mutex<Level> has a fixed level and a thread may only acquire
+ * mutexes in strictly increasing level order. When the order is known at
+ * compile time (ranked_guard over several mutexes, or ranked_guard::then)
+ * it is checked with static_assert; otherwise lock() does a cheap check
+ * against the levels the calling thread already holds. try_lock() is not
+ * checked, it can't block and std::lock / std::scoped_lock rely on it to
+ * back off in any order.
+ *
+ * The mutexes talk to the tracker through deadlock.h instead of the
+ * interposed pthread symbols, so they still appear in deadlock reports.
+ * Without libdeadlock loaded they fall back to plain pthread calls.
+ *
+ * Like std::mutex, lock() throws std::system_error when the pthread call
+ * fails (e.g. EDEADLK under DEADLOCK_AVOID=1); the level is only recorded
+ * once the mutex is actually held.
+ */
+
+#include <pthread.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <system_error>
+#include "deadlock.h"
+
+// weak, so programs built with this header still run without libdeadlock
+extern "C" int deadlock_mutex_lock(pthread_mutex_t *mutex) __attribute__((weak));
+extern "C" int deadlock_mutex_unlock(pthread_mutex_t *mutex) __attribute__((weak));
+extern "C" int deadlock_mutex_trylock(pthread_mutex_t *mutex) __attribute__((weak));
+
+namespace deadlock {
+
+namespace detail {
+
+// deepest nesting of ranked mutexes held by one thread
+constexpr unsigned max_held = 32;
+
+struct held_levels {
+    unsigned levels[max_held];
+    unsigned count;
+};
+
+inline held_levels &held() {
+    static thread_local held_levels h = {{0}, 0};
+    return h;
+}
+
+inline void violation(const char *what, unsigned level, unsigned held_level) {
+    std::fprintf(stderr, "!!! Lock hierarchy violation !!! %s level %u while holding level %u\n",
+                 what, level, held_level);
+    std::abort();
+}
+
+inline void check_acquire(unsigned level) {
+    held_levels &h = held();
+    if (h.count > 0 && h.levels[h.count - 1] >= level) {
+        violation("acquiring", level, h.levels[h.count - 1]);
+    }
+}
+
+// keep the list sorted so the last entry is always the highest level held,
+// an out-of-order try_lock lands in the middle
+inline void push_level(unsigned level) {
+    held_levels &h = held();
+    if (h.count >= max_held) violation("too deep at", level, h.levels[h.count - 1]);
+    unsigned i = h.count++;
+    for (; i > 0 && h.levels[i - 1] > level; --i) h.levels[i] = h.levels[i - 1];
+    h.levels[i] = level;
+}
+
+// mutexes may be released out of order, so drop the newest matching entry
+inline void pop_level(unsigned level) {
+    held_levels &h = held();
+    for (unsigned i = h.count; i > 0; --i) {
+        if (h.levels[i - 1] == level) {
+            for (unsigned j = i; j < h.count; ++j) h.levels[j - 1] = h.levels[j];
+            --h.count;
+            return;
+        }
+    }
+}
+
+inline int raw_lock(pthread_mutex_t *m) {
+    return deadlock_mutex_lock ? deadlock_mutex_lock(m) : pthread_mutex_lock(m);
+}
+
+inline int raw_unlock(pthread_mutex_t *m) {
+    return deadlock_mutex_unlock ? deadlock_mutex_unlock(m) : pthread_mutex_unlock(m);
+}
+
+inline int raw_trylock(pthread_mutex_t *m) {
+    return deadlock_mutex_trylock ? deadlock_mutex_trylock(m) : pthread_mutex_trylock(m);
+}
+
+template <unsigned... Levels>
+struct strictly_increasing;
+
+template <>
+struct strictly_increasing<> { static constexpr bool value = true; };
+
+template <unsigned L>
+struct strictly_increasing<L> { static constexpr bool value = true; };
+
+template <unsigned A, unsigned B, unsigned... Rest>
+struct strictly_increasing<A, B, Rest...> {
+    static constexpr bool value = A < B && strictly_increasing<B, Rest...>::value;
+};
+
+} // namespace detail
+
+template <unsigned Level>
+class ranked_mutex {
+public:
+    static constexpr unsigned level = Level;
+
+    ranked_mutex() { pthread_mutex_init(&m_, nullptr); }
+    ~ranked_mutex() { pthread_mutex_destroy(&m_); }
+
+    ranked_mutex(const ranked_mutex &) = delete;
+    ranked_mutex &operator=(const ranked_mutex &) = delete;
+
+    // BasicLockable / Lockable, so std::lock_guard and std::unique_lock work too
+    void lock() {
+        detail::check_acquire(Level);
+        lock_unchecked();
+    }
+
+    bool try_lock() {
+        if (detail::raw_trylock(&m_) != 0) return false;
+        detail::push_level(Level);
+        return true;
+    }
+
+    // guards unlock from their destructors, so a failed unlock doesn't throw,
+    // it just leaves the level list alone (we weren't the owner)
+    void unlock() noexcept {
+        if (detail::raw_unlock(&m_) != 0) return;
+        detail::pop_level(Level);
+    }
+
+    pthread_mutex_t *native_handle() { return &m_; }
+
+private:
+    template <unsigned...> friend class ranked_guard;
+
+    // order already proven by ranked_guard, only record the level
+    void lock_unchecked() {
+        int rc = detail::raw_lock(&m_);
+        if (rc != 0) throw std::system_error(rc, std::generic_category(), "ranked_mutex::lock");
+        detail::push_level(Level);
+    }
+
+    pthread_mutex_t m_;
+};
+
+/*
+ * Scoped guard over one or more ranked mutexes. The levels must be strictly
+ * increasing, which is checked at compile time; mutexes are locked in that
+ * order and released in reverse.
+ */
+template <unsigned... Levels>
+class ranked_guard;
+
+template <unsigned Level>
+class ranked_guard<Level> {
+public:
+    explicit ranked_guard(ranked_mutex<Level> &m) : m_(m) { m_.lock(); }
+    ~ranked_guard() { m_.unlock(); }
+
+    ranked_guard(const ranked_guard &) = delete;
+    ranked_guard &operator=(const ranked_guard &) = delete;
+
+    // acquire the next mutex while holding this one. The order against this
+    // guard is checked statically, the runtime check still catches mutexes the
+    // thread locked in between through plain lock()
+    template <unsigned Next>
+    ranked_guard<Next> then(ranked_mutex<Next> &next) {
+        static_assert(Level < Next, "ranked_guard::then: lock order violates the hierarchy");
+        detail::check_acquire(Next);
+        return ranked_guard<Next>(next, typename ranked_guard<Next>::adopt_order{});
+    }
+
+private:
+    template <unsigned...> friend class ranked_guard;
+    struct adopt_order {};
+
+    ranked_guard(ranked_mutex<Level> &m, adopt_order) : m_(m) { m_.lock_unchecked(); }
+
+    ranked_mutex<Level> &m_;
+};
+
+template <unsigned First, unsigned Second, unsigned... Rest>
+class ranked_guard<First, Second, Rest...> {
+    static_assert(detail::strictly_increasing<First, Second, Rest...>::value,
+                  "ranked_guard: mutex levels must be strictly increasing");
+
+public:
+    ranked_guard(ranked_mutex<First> &first, ranked_mutex<Second> &second,
+                 ranked_mutex<Rest> &...rest)
+        : head_(first), tail_(second, rest..., typename tail_t::adopt_order{}) {}
+
+private:
+    template <unsigned...> friend class ranked_guard;
+    using tail_t = ranked_guard<Second, Rest...>;
+    struct adopt_order {};
+
+    ranked_guard(ranked_mutex<First> &first, ranked_mutex<Second> &second,
+                 ranked_mutex<Rest> &...rest, adopt_order)
+        : head_(first, typename ranked_guard<First>::adopt_order{}),
+          tail_(second, rest..., typename tail_t::adopt_order{}) {}
+
+    // members are destroyed in reverse, so the tail unlocks before the head
+    ranked_guard<First> head_;
+    tail_t tail_;
+};
+
+} // namespace deadlock
+
+#endif
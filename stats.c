@@ -0,0 +1,199 @@
+#define _GNU_SOURCE
+#include "stats.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Slots are recycled when their thread exits, so this bounds the number of
+ * *live* threads with a private slot; any beyond it share the overflow slot.
+ * The array is in .bss, only slots that are actually used get paged in.
+ */
+#define MAX_STAT_SLOTS 8192
+
+typedef struct {
+    _Alignas(64) _Atomic uint64_t v[STAT_COUNT]; // own cache lines, no false sharing
+    int next_free;
+} stat_slot_t;
+
+int stats_enabled = 0;
+
+static stat_slot_t slots[MAX_STAT_SLOTS];
+static stat_slot_t overflow_slot;
+static stat_slot_t retired;               // totals of threads that have exited
+static atomic_size_t slot_count = 0;      // high-water mark of slots[]
+static int free_head = -1;                // recycled slots, protected by free_lock
+static atomic_flag free_lock = ATOMIC_FLAG_INIT;
+static pthread_key_t slot_key;
+static __thread stat_slot_t *my_slot = NULL;
+
+static const struct {
+    const char *name;
+    int is_max;
+} stat_desc[STAT_COUNT] = {
+    [STAT_HOOK_CALLS]      = { "hook calls", 0 },
+    [STAT_HOOK_NS]         = { "hook time (ns)", 0 },
+    [STAT_SPIN_ACQUIRES]   = { "spinlock acquires", 0 },
+    [STAT_SPIN_ITERS]      = { "spinlock spin iterations", 0 },
+    [STAT_UNWIND_CALLS]    = { "stack captures", 0 },
+    [STAT_UNWIND_NS]       = { "stack capture time (ns)", 0 },
+    [STAT_LOOKUPS]         = { "table lookups", 0 },
+    [STAT_PROBES]          = { "table probes", 0 },
+    [STAT_PROBE_MAX]       = { "longest probe", 1 },
+    [STAT_SCANS]           = { "monitor scans", 0 },
+    [STAT_SCAN_NS]         = { "monitor scan time (ns)", 0 },
+    [STAT_SCAN_NS_MAX]     = { "slowest scan (ns)", 1 },
+    [STAT_GRAPH_NODES_MAX] = { "largest graph (nodes)", 1 },
+    [STAT_GRAPH_EDGES_MAX] = { "largest graph (edges)", 1 },
+};
+
+static void free_lock_acq(void) {
+    while (atomic_flag_test_and_set_explicit(&free_lock, memory_order_acquire)) {
+        // busy-wait, only taken on thread start/exit
+    }
+}
+
+static void free_lock_rel(void) {
+    atomic_flag_clear_explicit(&free_lock, memory_order_release);
+}
+
+/*
+ * TLS destructor: fold the exiting thread's counters into 'retired', clear
+ * the slot and put it back on the free list. A collect running concurrently
+ * may count those values twice or not at all for that instant. Anything the
+ * thread counts after this (a later TLS destructor taking a lock) goes to the
+ * overflow slot, re-registering would just run the destructor again.
+ */
+static void release_slot(void *p) {
+    stat_slot_t *s = p;
+    for (int i = 0; i < STAT_COUNT; ++i) {
+        uint64_t v = atomic_exchange_explicit(&s->v[i], 0, memory_order_relaxed);
+        if (stat_desc[i].is_max) {
+            uint64_t cur = atomic_load_explicit(&retired.v[i], memory_order_relaxed);
+            while (v > cur && !atomic_compare_exchange_weak_explicit(&retired.v[i], &cur, v,
+                                                                     memory_order_relaxed, memory_order_relaxed)) {
+            }
+        } else {
+            atomic_fetch_add_explicit(&retired.v[i], v, memory_order_relaxed);
+        }
+    }
+
+    free_lock_acq();
+    s->next_free = free_head;
+    free_head = (int)(s - slots);
+    free_lock_rel();
+    my_slot = &overflow_slot;
+}
+
+static stat_slot_t *get_slot(void) {
+    if (my_slot) return my_slot;
+
+    free_lock_acq();
+    if (free_head >= 0) {
+        my_slot = &slots[free_head];
+        free_head = my_slot->next_free;
+    } else {
+        size_t idx = atomic_load_explicit(&slot_count, memory_order_relaxed);
+        if (idx < MAX_STAT_SLOTS) {
+            my_slot = &slots[idx];
+            atomic_store(&slot_count, idx + 1);
+        }
+    }
+    free_lock_rel();
+
+    if (!my_slot) {
+        my_slot = &overflow_slot;
+    } else {
+        pthread_setspecific(slot_key, my_slot);
+    }
+    return my_slot;
+}
+
+void stats_init(void) {
+    if (pthread_key_create(&slot_key, release_slot) != 0) return;
+    stats_enabled = 1;
+}
+
+void stats_add(stat_id_t id, uint64_t v) {
+    stat_slot_t *s = get_slot();
+    if (s == &overflow_slot) {
+        atomic_fetch_add_explicit(&s->v[id], v, memory_order_relaxed);
+        return;
+    }
+    // single writer per slot, a plain load/store pair avoids the locked add
+    uint64_t cur = atomic_load_explicit(&s->v[id], memory_order_relaxed);
+    atomic_store_explicit(&s->v[id], cur + v, memory_order_relaxed);
+}
+
+void stats_max(stat_id_t id, uint64_t v) {
+    stat_slot_t *s = get_slot();
+    uint64_t cur = atomic_load_explicit(&s->v[id], memory_order_relaxed);
+    while (v > cur) {
+        if (atomic_compare_exchange_weak_explicit(&s->v[id], &cur, v,
+                                                  memory_order_relaxed, memory_order_relaxed)) break;
+    }
+}
+
+uint64_t stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void collect_slot(uint64_t *out, stat_slot_t *s) {
+    for (int i = 0; i < STAT_COUNT; ++i) {
+        uint64_t v = atomic_load_explicit(&s->v[i], memory_order_relaxed);
+        if (stat_desc[i].is_max) {
+            if (v > out[i]) out[i] = v;
+        } else {
+            out[i] += v;
+        }
+    }
+}
+
+void stats_collect(uint64_t *out) {
+    memset(out, 0, sizeof(uint64_t) * STAT_COUNT);
+    size_t n = atomic_load(&slot_count);
+    if (n > MAX_STAT_SLOTS) n = MAX_STAT_SLOTS;
+    for (size_t i = 0; i < n; ++i) collect_slot(out, &slots[i]);
+    collect_slot(out, &overflow_slot);
+    collect_slot(out, &retired);
+}
+
+// snprintf isn't async-signal-safe, so format by hand
+static size_t append_str(char *buf, size_t pos, size_t cap, const char *s) {
+    while (*s && pos < cap) buf[pos++] = *s++;
+    return pos;
+}
+
+static size_t append_u64(char *buf, size_t pos, size_t cap, uint64_t v) {
+    char tmp[24];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n && pos < cap) buf[pos++] = tmp[--n];
+    return pos;
+}
+
+void stats_print(int fd) {
+    uint64_t totals[STAT_COUNT];
+    stats_collect(totals);
+
+    char buf[128];
+    size_t pos = append_str(buf, 0, sizeof(buf), "=== Deadlock Detector Stats ===\n");
+    ssize_t _r = write(fd, buf, pos);
+
+    for (int i = 0; i < STAT_COUNT; ++i) {
+        pos = append_str(buf, 0, sizeof(buf), " ");
+        pos = append_str(buf, pos, sizeof(buf), stat_desc[i].name);
+        pos = append_str(buf, pos, sizeof(buf), ": ");
+        pos = append_u64(buf, pos, sizeof(buf), totals[i]);
+        pos = append_str(buf, pos, sizeof(buf), "\n");
+        _r = write(fd, buf, pos);
+    }
+    (void)_r;
+}
@@ -0,0 +1,56 @@
+#ifndef DEADLOCK_STATS_H
+#define DEADLOCK_STATS_H
+
+#include <stdint.h>
+
+/*
+ * Self-profiling counters for the detector's own overhead. Every thread
+ * writes only to its own slot, aggregation sums (or maxes) over all slots.
+ * Slots are recycled on thread exit, their counts are kept in a retired total.
+ * Everything is a no-op unless stats_enabled is set (DEADLOCK_STATS=1).
+ */
+
+typedef enum {
+    STAT_HOOK_CALLS = 0,   // tracked lock/trylock/unlock calls
+    STAT_HOOK_NS,          // time spent in the hooks, excluding blocking in the real lock
+    STAT_SPIN_ACQUIRES,    // spinlock_acq calls
+    STAT_SPIN_ITERS,       // busy-wait iterations in spinlock_acq
+    STAT_UNWIND_CALLS,     // stack captures
+    STAT_UNWIND_NS,        // time spent capturing stacks
+    STAT_LOOKUPS,          // tracker table lookups
+    STAT_PROBES,           // entries examined by those lookups
+    STAT_PROBE_MAX,        // longest single lookup
+    STAT_SCANS,            // monitor scans
+    STAT_SCAN_NS,          // time spent building the graph and searching it
+    STAT_SCAN_NS_MAX,      // slowest single scan
+    STAT_GRAPH_NODES_MAX,  // largest wait-for graph seen (nodes)
+    STAT_GRAPH_EDGES_MAX,  // largest wait-for graph seen (edges)
+    STAT_COUNT
+} stat_id_t;
+
+extern int stats_enabled;
+
+// turn the counters on (DEADLOCK_STATS=1), call once before any thread uses them
+void stats_init(void);
+
+void stats_add(stat_id_t id, uint64_t v);
+void stats_max(stat_id_t id, uint64_t v);
+uint64_t stats_now_ns(void);
+
+// sum/max of all threads' counters into out[STAT_COUNT]
+void stats_collect(uint64_t *out);
+
+// async-signal-safe, so it can run from a signal handler
+void stats_print(int fd);
+
+static inline uint64_t stats_clock(void) {
+    return stats_enabled ? stats_now_ns() : 0;
+}
+
+static inline void stats_elapsed(stat_id_t id, uint64_t start) {
+    if (stats_enabled) stats_add(id, stats_now_ns() - start);
+}
+
+#define STATS_ADD(id, v) do { if (stats_enabled) stats_add((id), (v)); } while (0)
+
+#endif
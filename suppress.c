@@ -0,0 +1,177 @@
+#define _GNU_SOURCE
+#include "suppress.h"
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    char name[128];
+    uintptr_t offset; // callsite offset into the symbol
+    int has_offset;
+    int resolved;
+} suppress_entry_t;
+
+static int parse_line(char *line, suppress_entry_t *e) {
+    char *hash = strchr(line, '#');
+    if (hash) *hash = '\0';
+
+    char *start = line;
+    while (*start == ' ' || *start == '\t') start++;
+    char *end = start + strcspn(start, " \t\r\n");
+    *end = '\0';
+    if (*start == '\0') return 0;
+
+    memset(e, 0, sizeof(*e));
+    char *plus = strchr(start, '+');
+    if (plus) {
+        *plus = '\0';
+        e->offset = (uintptr_t)strtoull(plus + 1, NULL, 0);
+        e->has_offset = 1;
+    }
+    snprintf(e->name, sizeof(e->name), "%s", start);
+    return 1;
+}
+
+static void add_range(suppress_filter_t *f, suppress_entry_t *e, uintptr_t addr, size_t size) {
+    if (f->count >= MAX_SUPPRESSIONS) return;
+    addr_range_t *r = &f->ranges[f->count++];
+    if (e->has_offset) {
+        r->start = addr + e->offset;
+        r->end = r->start + 1;
+    } else {
+        r->start = addr;
+        r->end = addr + (size ? size : 1);
+    }
+    e->resolved = 1;
+}
+
+static int main_base_cb(struct dl_phdr_info *info, size_t size, void *data) {
+    (void)size;
+    *(uintptr_t *)data = (uintptr_t)info->dlpi_addr;
+    return 1; // the first object is the main program
+}
+
+/*
+ * dlsym only sees exported symbols, so names from the executable itself are
+ * looked up in its own .symtab/.dynsym (this also covers static binaries).
+ */
+static void resolve_from_exe(suppress_filter_t *f, suppress_entry_t *entries, size_t n) {
+    int fd = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ElfW(Ehdr))) {
+        close(fd);
+        return;
+    }
+    const unsigned char *img = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (img == MAP_FAILED) return;
+
+    const ElfW(Ehdr) *eh = (const ElfW(Ehdr) *)img;
+    uintptr_t base = 0;
+    dl_iterate_phdr(main_base_cb, &base);
+
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) == 0 &&
+        eh->e_shoff + (size_t)eh->e_shnum * sizeof(ElfW(Shdr)) <= (size_t)st.st_size) {
+        const ElfW(Shdr) *sh = (const ElfW(Shdr) *)(img + eh->e_shoff);
+
+        for (size_t s = 0; s < eh->e_shnum; ++s) {
+            if (sh[s].sh_type != SHT_SYMTAB && sh[s].sh_type != SHT_DYNSYM) continue;
+            if (sh[s].sh_link >= eh->e_shnum) continue;
+
+            const ElfW(Shdr) *strsh = &sh[sh[s].sh_link];
+            if (sh[s].sh_offset + sh[s].sh_size > (size_t)st.st_size) continue;
+            if (strsh->sh_offset + strsh->sh_size > (size_t)st.st_size) continue;
+
+            const ElfW(Sym) *syms = (const ElfW(Sym) *)(img + sh[s].sh_offset);
+            const char *strtab = (const char *)(img + strsh->sh_offset);
+            size_t nsyms = sh[s].sh_size / sizeof(ElfW(Sym));
+
+            for (size_t i = 0; i < nsyms; ++i) {
+                if (ELF64_ST_TYPE(syms[i].st_info) != STT_FUNC || syms[i].st_value == 0) continue;
+                if (syms[i].st_name >= strsh->sh_size) continue;
+                const char *name = strtab + syms[i].st_name;
+
+                for (size_t k = 0; k < n; ++k) {
+                    if (entries[k].resolved || strcmp(entries[k].name, name) != 0) continue;
+                    add_range(f, &entries[k], base + syms[i].st_value, syms[i].st_size);
+                }
+            }
+        }
+    }
+    munmap((void *)img, st.st_size);
+}
+
+// anything left (symbols of shared libraries) goes through the dynamic linker
+static void resolve_from_dlsym(suppress_filter_t *f, suppress_entry_t *entries, size_t n) {
+    for (size_t k = 0; k < n; ++k) {
+        if (entries[k].resolved) continue;
+
+        void *addr = dlsym(RTLD_DEFAULT, entries[k].name);
+        if (!addr) continue;
+
+        Dl_info info;
+        const ElfW(Sym) *sym = NULL;
+        size_t size = 0;
+        if (dladdr1(addr, &info, (void **)&sym, RTLD_DL_SYMENT) && sym) {
+            size = sym->st_size;
+        }
+        add_range(f, &entries[k], (uintptr_t)addr, size);
+    }
+}
+
+static int cmp_range(const void *a, const void *b) {
+    const addr_range_t *x = a, *y = b;
+    return (x->start > y->start) - (x->start < y->start);
+}
+
+int suppress_load(suppress_filter_t *f, const char *path) {
+    f->count = 0;
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+
+    static suppress_entry_t entries[MAX_SUPPRESSIONS]; // only used once, at startup
+    size_t n = 0;
+    char line[256];
+    while (n < MAX_SUPPRESSIONS && fgets(line, sizeof(line), fp)) {
+        if (parse_line(line, &entries[n])) n++;
+    }
+    fclose(fp);
+
+    resolve_from_exe(f, entries, n);
+    resolve_from_dlsym(f, entries, n);
+
+    int resolved = 0;
+    for (size_t k = 0; k < n; ++k) {
+        if (entries[k].resolved) {
+            resolved++;
+        } else {
+            char buf[256];
+            int len = snprintf(buf, sizeof(buf), "WARNING: suppression '%s' did not resolve\n", entries[k].name);
+            ssize_t _r = write(2, buf, len);
+            (void)_r;
+        }
+    }
+
+    // sort and merge so suppress_match can binary search disjoint ranges
+    qsort(f->ranges, f->count, sizeof(addr_range_t), cmp_range);
+    size_t out = 0;
+    for (size_t i = 0; i < f->count; ++i) {
+        if (out > 0 && f->ranges[i].start <= f->ranges[out - 1].end) {
+            if (f->ranges[i].end > f->ranges[out - 1].end) f->ranges[out - 1].end = f->ranges[i].end;
+        } else {
+            f->ranges[out++] = f->ranges[i];
+        }
+    }
+    f->count = out;
+    return resolved;
+}
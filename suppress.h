@@ -0,0 +1,42 @@
+#ifndef DEADLOCK_SUPPRESS_H
+#define DEADLOCK_SUPPRESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX_SUPPRESSIONS 256
+
+typedef struct {
+    uintptr_t start; // inclusive
+    uintptr_t end;   // exclusive
+} addr_range_t;
+
+/*
+ * Immutable set of code ranges, sorted and merged so a lookup is a single
+ * binary search. Built once at startup, read without locking afterwards.
+ */
+typedef struct {
+    addr_range_t ranges[MAX_SUPPRESSIONS];
+    size_t count;
+} suppress_filter_t;
+
+/*
+ * Load a suppression file. One entry per line, '#' starts a comment:
+ *   symbol          suppress every acquisition made from inside symbol
+ *   symbol+0x1f     suppress one callsite (return address, as printed by backtrace_symbols)
+ * Returns the number of entries that resolved to an address, -1 if the file can't be read.
+ */
+int suppress_load(suppress_filter_t *f, const char *path);
+
+static inline int suppress_match(const suppress_filter_t *f, uintptr_t addr) {
+    size_t lo = 0, hi = f->count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (addr < f->ranges[mid].start) hi = mid;
+        else if (addr >= f->ranges[mid].end) lo = mid + 1;
+        else return 1;
+    }
+    return 0;
+}
+
+#endif
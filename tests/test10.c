@@ -0,0 +1,44 @@
+// Deadlock should be detected (run with DEADLOCK_SUPPRESS=tests/test10.supp)
+// The final tracker state must only list A and B, never counter_lock.
+#include <pthread.h>
+#include <unistd.h>
+#include <stdio.h>
+
+pthread_mutex_t A = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t B = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t counter_lock = PTHREAD_MUTEX_INITIALIZER;
+long counter = 0;
+
+__attribute__((noinline)) void hot_counter(void) {
+    pthread_mutex_lock(&counter_lock);
+    counter++;
+    pthread_mutex_unlock(&counter_lock);
+}
+
+void* t1(void* arg) {
+    for (int i = 0; i < 100000; i++) hot_counter();
+    pthread_mutex_lock(&A);
+    usleep(100000);
+    pthread_mutex_lock(&B);
+    return NULL;
+}
+
+void* t2(void* arg) {
+    for (int i = 0; i < 100000; i++) hot_counter();
+    pthread_mutex_lock(&B);
+    usleep(100000);
+    pthread_mutex_lock(&A);
+    return NULL;
+}
+
+int main() {
+    printf("A=%p B=%p counter_lock=%p\n", (void*)&A, (void*)&B, (void*)&counter_lock);
+    fflush(stdout);
+
+    pthread_t p1, p2;
+    pthread_create(&p1, NULL, t1, NULL);
+    pthread_create(&p2, NULL, t2, NULL);
+    pthread_join(p1, NULL);
+    pthread_join(p2, NULL);
+    return 0;
+}
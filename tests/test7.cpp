@@ -0,0 +1,54 @@
+// should pass (ranked mutexes, always taken in hierarchy order)
+#include <pthread.h>
+#include <unistd.h>
+#include <mutex>
+#include "../ranked_mutex.hpp"
+
+deadlock::ranked_mutex<10> accounts;
+deadlock::ranked_mutex<20> ledger;
+deadlock::ranked_mutex<30> audit_log;
+
+void* transfer(void* arg) {
+    for (int i = 0; i < 100; i++) {
+        deadlock::ranked_guard<10, 20> g(accounts, ledger);
+        usleep(100);
+    }
+    return NULL;
+}
+
+void* audit(void* arg) {
+    for (int i = 0; i < 100; i++) {
+        deadlock::ranked_guard<20> g(ledger);
+        auto log = g.then(audit_log);
+        usleep(100);
+    }
+    return NULL;
+}
+
+void* report(void* arg) {
+    for (int i = 0; i < 100; i++) {
+        std::lock_guard<deadlock::ranked_mutex<10>> a(accounts);
+        std::lock_guard<deadlock::ranked_mutex<30>> l(audit_log);
+        usleep(100);
+    }
+    return NULL;
+}
+
+// std::scoped_lock locks ledger and then try_locks accounts, which must not abort
+void* reconcile(void* arg) {
+    for (int i = 0; i < 100; i++) {
+        std::scoped_lock lk(ledger, accounts);
+        usleep(100);
+    }
+    return NULL;
+}
+
+int main() {
+    pthread_t p1, p2, p3, p4;
+    pthread_create(&p1, NULL, transfer, NULL);
+    pthread_create(&p2, NULL, audit, NULL);
+    pthread_create(&p3, NULL, report, NULL);
+    pthread_create(&p4, NULL, reconcile, NULL);
+    pthread_join(p1, NULL); pthread_join(p2, NULL); pthread_join(p3, NULL); pthread_join(p4, NULL);
+    return 0;
+}
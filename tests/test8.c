@@ -0,0 +1,27 @@
+// Deadlock should be detected (large graph, one cycle among many independent groups)
+#include <pthread.h>
+#include <unistd.h>
+
+#define GROUPS 40
+#define PER_GROUP 3
+pthread_mutex_t locks[GROUPS][PER_GROUP];
+
+// every group is a chain T0 <- T1 <- T2, only the last group closes the circle
+void* worker(void* arg) {
+    long id = (long)arg;
+    long g = id / PER_GROUP, i = id % PER_GROUP;
+    pthread_mutex_lock(&locks[g][i]);
+    sleep(1);
+    if (i > 0) pthread_mutex_lock(&locks[g][i - 1]);
+    else if (g == GROUPS - 1) pthread_mutex_lock(&locks[g][PER_GROUP - 1]);
+    else sleep(10);
+    return NULL;
+}
+
+int main() {
+    pthread_t threads[GROUPS * PER_GROUP];
+    for(int g=0; g<GROUPS; g++) for(int i=0; i<PER_GROUP; i++) pthread_mutex_init(&locks[g][i], NULL);
+    for(long i=0; i<GROUPS * PER_GROUP; i++) pthread_create(&threads[i], NULL, worker, (void*)i);
+    for(int i=0; i<GROUPS * PER_GROUP; i++) pthread_join(threads[i], NULL);
+    return 0;
+}
@@ -0,0 +1,34 @@
+// should pass with DEADLOCK_AVOID=1 (one lock fails with EDEADLK), deadlock detected without it
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+
+pthread_mutex_t A = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t B = PTHREAD_MUTEX_INITIALIZER;
+
+void* locker(void* arg) {
+    pthread_mutex_t *first = arg == NULL ? &A : &B;
+    pthread_mutex_t *second = arg == NULL ? &B : &A;
+
+    pthread_mutex_lock(first);
+    usleep(100000);
+    int rc = pthread_mutex_lock(second);
+    if (rc == EDEADLK) {
+        printf("Got EDEADLK, backing off\n");
+    } else {
+        pthread_mutex_unlock(second);
+    }
+    pthread_mutex_unlock(first);
+    return NULL;
+}
+
+int main() {
+    pthread_t p1, p2;
+    pthread_create(&p1, NULL, locker, NULL);
+    pthread_create(&p2, NULL, locker, (void*)1);
+    pthread_join(p1, NULL);
+    pthread_join(p2, NULL);
+    printf("Test 9 finished successfully.\n");
+    return 0;
+}
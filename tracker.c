@@ -1,11 +1,11 @@
 #define _GNU_SOURCE
 #include "tracker.h"
 #include "graph.h" 
+#include "stats.h"
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdlib.h>
-#include <execinfo.h>
 
 static inline void safe_write(int fd, const void *buf, size_t n) {
     ssize_t _r = write(fd, buf, n);
@@ -13,9 +13,13 @@ static inline void safe_write(int fd, const void *buf, size_t n) {
 }
 
 void spinlock_acq(atomic_flag *f) {
+    uint64_t spins = 0;
     while (atomic_flag_test_and_set_explicit(f, memory_order_acquire)) {
         // busy-wait
+        spins++;
     }
+    STATS_ADD(STAT_SPIN_ACQUIRES, 1);
+    if (spins) STATS_ADD(STAT_SPIN_ITERS, spins);
 }
 
 void spinlock_rel(atomic_flag *f) {
@@ -24,10 +28,22 @@ void spinlock_rel(atomic_flag *f) {
 
 // helpers to find or create entries
 
+// probe lengths are the main cost of the linear tables, so they're counted
+static inline void count_probes(size_t probes) {
+    if (!stats_enabled) return;
+    stats_add(STAT_LOOKUPS, 1);
+    stats_add(STAT_PROBES, probes);
+    stats_max(STAT_PROBE_MAX, probes);
+}
+
 static mutex_info_t *find_mutex_entry(simple_tracker_t *t, pthread_mutex_t *m) {
     for (size_t i = 0; i < t->mutex_count; i++) {
-        if (t->mutexes[i].mutex == m) return &t->mutexes[i];
+        if (t->mutexes[i].mutex == m) {
+            count_probes(i + 1);
+            return &t->mutexes[i];
+        }
     }
+    count_probes(t->mutex_count);
     return NULL;
 }
 
@@ -43,8 +59,12 @@ static mutex_info_t *get_or_create_mutex_entry(simple_tracker_t *t, pthread_mute
 
 static thread_info_t *find_thread_entry(simple_tracker_t *t, pthread_t tid) {
     for (size_t i = 0; i < t->thread_count; i++) {
-        if (t->threads[i].tid == tid) return &t->threads[i];
+        if (t->threads[i].tid == tid) {
+            count_probes(i + 1);
+            return &t->threads[i];
+        }
     }
+    count_probes(t->thread_count);
     return NULL;
 }
 
@@ -63,6 +83,8 @@ static thread_info_t *get_or_create_thread_entry(simple_tracker_t *t, pthread_t
 void tracker_init(simple_tracker_t *t) {
     t->mutex_count = 0;
     t->thread_count = 0;
+    t->stack_depth = DEFAULT_STACK_DEPTH;
+    t->unwind = UNWIND_BACKTRACE;
     atomic_flag_clear_explicit(&t->lock, memory_order_release);
 }
 
@@ -87,19 +109,24 @@ void tracker_lock_acquired(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *
 void tracker_lock_released(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m) {
     spinlock_acq(&t->lock);
 
+    // only clear our own ownership, another thread may already have taken m
+    // between the real unlock and this call
     mutex_info_t *me = find_mutex_entry(t, m);
-    if (me) me->owner = (pthread_t)0;
+    if (me && me->owner == tid) me->owner = (pthread_t)0;
 
     spinlock_rel(&t->lock);
 }
 
 // Called when tid is blocked waiting for m 
-void tracker_waiting(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m) {
-    void *temp_stack[10];
+void tracker_waiting(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m, void *caller) {
+    void *temp_stack[MAX_STACK_DEPTH];
     int frames = 0;
     
     if (m != NULL) {
-        frames = backtrace(temp_stack, 10);
+        uint64_t start = stats_clock();
+        frames = unwind_capture(t->unwind, temp_stack, t->stack_depth, caller);
+        STATS_ADD(STAT_UNWIND_CALLS, 1);
+        stats_elapsed(STAT_UNWIND_NS, start);
     }
 
     spinlock_acq(&t->lock);
@@ -118,6 +145,93 @@ void tracker_waiting(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m) {
     spinlock_rel(&t->lock);
 }
 
+/*
+ * Bounded lookups for the avoidance walk: every table slot looked at is charged
+ * to *budget, and once it runs out the lookup fails as if nothing was found.
+ */
+static mutex_info_t *find_mutex_bounded(simple_tracker_t *t, pthread_mutex_t *m, size_t *budget) {
+    size_t n = t->mutex_count < *budget ? t->mutex_count : *budget;
+    for (size_t i = 0; i < n; i++) {
+        if (t->mutexes[i].mutex == m) {
+            *budget -= i + 1;
+            return &t->mutexes[i];
+        }
+    }
+    *budget -= n;
+    return NULL;
+}
+
+static thread_info_t *find_thread_bounded(simple_tracker_t *t, pthread_t tid, size_t *budget) {
+    size_t n = t->thread_count < *budget ? t->thread_count : *budget;
+    for (size_t i = 0; i < n; i++) {
+        if (t->threads[i].tid == tid) {
+            *budget -= i + 1;
+            return &t->threads[i];
+        }
+    }
+    *budget -= n;
+    return NULL;
+}
+
+int tracker_waiting_checked(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m, void *caller,
+                            pthread_t *chain, size_t *chain_len) {
+    spinlock_acq(&t->lock);
+
+    // walk: m -> owner -> mutex the owner waits for -> its owner ...
+    size_t len = 0;
+    size_t budget = AVOID_MAX_PROBES;
+    int cycle = 0;
+    chain[len++] = tid;
+    pthread_mutex_t *cur = m;
+    while (cur && len < AVOID_MAX_CHAIN) {
+        mutex_info_t *me = find_mutex_bounded(t, cur, &budget);
+        if (!me || me->owner == (pthread_t)0) break;
+        if (me->owner == tid) {
+            cycle = 1;
+            break;
+        }
+        chain[len++] = me->owner;
+
+        thread_info_t *owner = find_thread_bounded(t, me->owner, &budget);
+        cur = owner ? owner->waiting : NULL;
+    }
+
+    thread_info_t *info = NULL;
+    if (!cycle) {
+        // record the wait now so a racing thread sees it, the stack follows below
+        info = get_or_create_thread_entry(t, tid);
+        if (info) {
+            info->waiting = m;
+            info->frames = 0;
+        }
+    }
+
+    spinlock_rel(&t->lock);
+
+    if (cycle) {
+        *chain_len = len;
+        return 1;
+    }
+    *chain_len = 0;
+    if (!info) return 0;
+
+    // only pay for the capture once we know we are going to block
+    void *temp_stack[MAX_STACK_DEPTH];
+    uint64_t start = stats_clock();
+    int frames = unwind_capture(t->unwind, temp_stack, t->stack_depth, caller);
+    STATS_ADD(STAT_UNWIND_CALLS, 1);
+    stats_elapsed(STAT_UNWIND_NS, start);
+
+    // entries are never removed and only this thread changes its own wait
+    spinlock_acq(&t->lock);
+    if (info->waiting == m) {
+        info->frames = frames;
+        memcpy(info->callstack, temp_stack, sizeof(void*) * frames);
+    }
+    spinlock_rel(&t->lock);
+    return 0;
+}
+
 // simple debug print
 void tracker_print_state(simple_tracker_t *t) {
     spinlock_acq(&t->lock);
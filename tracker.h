@@ -4,12 +4,18 @@
 #include <pthread.h>
 #include <stdatomic.h>
 #include <stddef.h>
+#include "unwind.h"
 
 // you can increase these numbers it you are planning to run a big project,
 // but remember that you have to then change O(n) access into O(1) with hashmap
 #define MAX_MUTEXES 256
 #define MAX_THREADS 256
 
+// max owner hops followed by tracker_waiting_checked before giving up
+#define AVOID_MAX_CHAIN 32
+// table slots the avoidance walk may look at in total, it runs under the spinlock
+#define AVOID_MAX_PROBES 1024
+
 typedef struct {
     pthread_mutex_t *mutex; // key
     pthread_t owner;        // 0 if free
@@ -18,7 +24,7 @@ typedef struct {
 typedef struct {
     pthread_t tid;            // key
     pthread_mutex_t *waiting; // NULL if not waiting
-    void *callstack[10];      // Storage for stack frames (customizible)
+    void *callstack[MAX_STACK_DEPTH]; // Storage for stack frames
     int frames;               // Number of frames captured
 } thread_info_t;
 
@@ -30,15 +36,30 @@ typedef struct {
     size_t thread_count;
 
     atomic_flag lock; // spinlock to protect the arrays
+
+    int stack_depth;          // frames captured per wait (<= MAX_STACK_DEPTH)
+    unwind_mode_t unwind;     // how tracker_waiting captures stacks
 } simple_tracker_t;
 
 void tracker_init(simple_tracker_t *t);
 void tracker_destroy(simple_tracker_t *t);
 
-// called by interceptors 
+// called by interceptors, 'caller' is the hook's return address (stack captures start there)
 void tracker_lock_acquired(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m);
 void tracker_lock_released(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m);
-void tracker_waiting(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m);
+void tracker_waiting(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m, void *caller);
+
+/*
+ * Like tracker_waiting, but first follows the owner -> waiting-for chain from m
+ * (at most AVOID_MAX_CHAIN hops and AVOID_MAX_PROBES table slots, past that the
+ * wait is allowed and left to the monitor). If it leads back to tid, blocking
+ * would close a cycle: nothing is recorded, no stack is captured, chain[] gets
+ * the threads involved starting with tid, and 1 is returned. Check and record
+ * happen under one lock, so two threads racing into the same cycle can't both
+ * pass; the stack is captured afterwards, outside the lock.
+ */
+int tracker_waiting_checked(simple_tracker_t *t, pthread_t tid, pthread_mutex_t *m, void *caller,
+                            pthread_t *chain, size_t *chain_len);
 
 // Debug print current state
 void tracker_print_state(simple_tracker_t *t);
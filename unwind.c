@@ -0,0 +1,113 @@
+#define _GNU_SOURCE
+#include "unwind.h"
+#include <stdint.h>
+#include <string.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// bounds of the calling thread's stack mapping, looked up once per thread
+static __thread uintptr_t stack_lo, stack_hi;
+static __thread int stack_state; // 0 = not looked up, 1 = known, -1 = lookup failed
+
+/*
+ * Find the mapping in /proc/self/maps that contains our own frame. This uses
+ * raw open/read and a small buffer on the stack, no stdio and no malloc, so it
+ * is safe inside a lock hook. Thread stacks are separate mappings fenced by a
+ * PROT_NONE guard, so the mapping is exactly the readable part of the stack.
+ */
+static int lookup_stack_bounds(void) {
+    uintptr_t sp = (uintptr_t)__builtin_frame_address(0);
+    int fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    char buf[1024];
+    uintptr_t start = 0, end = 0;
+    int field = 0; // 0 = start, 1 = end, 2 = rest of the line
+    int found = -1;
+    ssize_t len;
+
+    while (found < 0 && (len = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < len; ++i) {
+            char c = buf[i];
+            if (c == '\n') {
+                if (field == 2 && start <= sp && sp < end) {
+                    stack_lo = start;
+                    stack_hi = end;
+                    found = 1;
+                    break;
+                }
+                start = end = 0;
+                field = 0;
+            } else if (field < 2) {
+                int d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+                if (d >= 0) {
+                    if (field == 0) start = start << 4 | d;
+                    else end = end << 4 | d;
+                } else {
+                    field = c == '-' && field == 0 ? 1 : 2;
+                }
+            }
+        }
+    }
+    close(fd);
+    return found;
+}
+
+/*
+ * Walk the frame-pointer chain. Every frame is laid out as
+ * [fp] = caller's fp, [fp + 1] = return address, and both slots must lie in
+ * the thread's stack mapping. We stop as soon as a frame leaves it, is
+ * misaligned or doesn't move towards the stack base, so a frame compiled
+ * without frame pointers just ends the walk. Returns -1 if the stack bounds
+ * could not be found.
+ */
+__attribute__((noinline))
+static int unwind_frame_pointer(void **buf, int max) {
+    if (stack_state == 0) stack_state = lookup_stack_bounds();
+    if (stack_state < 0) return -1;
+
+    uintptr_t fp = (uintptr_t)__builtin_frame_address(0);
+    int n = 0;
+
+    while (n < max) {
+        if (fp < stack_lo || fp > stack_hi - 2 * sizeof(void *)) break;
+        if (fp & (sizeof(void *) - 1)) break;
+
+        void **frame = (void **)fp;
+        void *ret = frame[1];
+        if (!ret) break;
+        buf[n++] = ret;
+
+        uintptr_t next = (uintptr_t)frame[0];
+        if (next <= fp) break;
+        fp = next;
+    }
+    return n;
+}
+
+int unwind_capture(unwind_mode_t mode, void **buf, int max, void *caller) {
+    if (max <= 0) return 0;
+    if (max > MAX_STACK_DEPTH) max = MAX_STACK_DEPTH;
+
+    // capture a few extra frames to cover our own, then drop everything above the caller
+    void *tmp[MAX_STACK_DEPTH + UNWIND_MAX_SKIP];
+    int want = max + (caller ? UNWIND_MAX_SKIP : 0);
+    int n = mode == UNWIND_FRAME_POINTER ? unwind_frame_pointer(tmp, want) : -1;
+    if (n < 0) n = backtrace(tmp, want);
+
+    int first = 0;
+    if (caller) {
+        for (int i = 0; i < n && i <= UNWIND_MAX_SKIP; ++i) {
+            if (tmp[i] == caller) {
+                first = i;
+                break;
+            }
+        }
+    }
+
+    n -= first;
+    if (n > max) n = max;
+    if (n > 0) memcpy(buf, tmp + first, sizeof(void *) * n);
+    return n;
+}
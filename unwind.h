@@ -0,0 +1,24 @@
+#ifndef DEADLOCK_UNWIND_H
+#define DEADLOCK_UNWIND_H
+
+// upper bound for captured frames, the runtime depth is clamped to this
+#define MAX_STACK_DEPTH 32
+#define DEFAULT_STACK_DEPTH 10
+
+// library frames (hook, tracker, unwinder) dropped from the top of a capture
+#define UNWIND_MAX_SKIP 8
+
+typedef enum {
+    UNWIND_BACKTRACE = 0, // glibc backtrace(), works everywhere but slow
+    UNWIND_FRAME_POINTER  // walks the rbp chain, needs -fno-omit-frame-pointer
+} unwind_mode_t;
+
+/*
+ * Capture up to 'max' return addresses of the calling thread into buf.
+ * If 'caller' (the hook's return address) is given, frames above it are
+ * skipped so the capture starts in application code.
+ * Returns the number of frames written.
+ */
+int unwind_capture(unwind_mode_t mode, void **buf, int max, void *caller);
+
+#endif